@@ -0,0 +1,49 @@
+import { SQLite, Database } from "../src/index";
+import * as fs from "node:fs/promises";
+
+const DOCUMENTS = 20000;
+
+const wasmFile = await fs.readFile("sqlite/sqlite3.wasm");
+const module = await WebAssembly.compile(wasmFile);
+const ngram = await WebAssembly.compile(await fs.readFile("sqlite/exts/ngram.wasm"));
+
+const words = ["lorem", "ipsum", "dolor", "sit", "amet", "Consectetur", "adipiscing", "elit", "東京都", "の天気", "검색", "エンジン"];
+const documents: string[] = [];
+let seed = 1;
+for (let i = 0; i < DOCUMENTS; i++) {
+	const doc: string[] = [];
+	for (let j = 0; j < 50; j++) {
+		seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+		doc.push(words[seed % words.length]);
+	}
+	documents.push(doc.join(" "));
+}
+const totalBytes = documents.reduce((n, doc) => n + Buffer.byteLength(doc), 0);
+
+async function bench(name: string, tokenize: string, setup?: (db: Database) => void) {
+	const sqlite = await SQLite.instantiate(module);
+	const db = sqlite.open(":memory:");
+	setup?.(db);
+	db.exec(`CREATE VIRTUAL TABLE docs USING fts5(body, tokenize = '${tokenize}')`);
+	const stmt = db.prepare("INSERT INTO docs (body) VALUES (?)")!;
+	const start = performance.now();
+	db.exec("BEGIN");
+	for (const doc of documents) {
+		for (const _ of stmt.exec(doc)) {}
+	}
+	db.exec("COMMIT");
+	const elapsed = performance.now() - start;
+	stmt.finalize();
+	db.close();
+	console.log(`${name}: ${(totalBytes / 1048576 / (elapsed / 1000)).toFixed(2)} MB/s`);
+}
+
+await bench("unicode61", "unicode61");
+await bench("ngram", "ngram", (db) => db.loadExtension(ngram));
+await bench("js (whitespace)", "js", (db) => db.createTokenizer("js", {
+	tokenize: (text) => Array.from(text.matchAll(/\S+/g), (m) => ({
+		token: m[0].toLowerCase(),
+		start: m.index!,
+		end: m.index! + m[0].length,
+	})),
+}));
@@ -0,0 +1,83 @@
+import * as fs from "node:fs/promises";
+
+import { SQLite, Database } from "../src/index";
+
+const ITERATIONS = 20;
+
+const wasmFile = await fs.readFile("sqlite/sqlite3.wasm");
+
+function firstQuery(db: Database) {
+	db.exec("SELECT count(*) FROM test");
+}
+
+async function measure(name: string, fn: () => Promise<void>) {
+	await fn();
+	const start = performance.now();
+	for (let i = 0; i < ITERATIONS; i++) {
+		await fn();
+	}
+	const elapsed = (performance.now() - start) / ITERATIONS;
+	console.log(`${name}: ${elapsed.toFixed(3)}ms`);
+}
+
+const seed = await SQLite.instantiate(await WebAssembly.compile(wasmFile));
+const seedDb = seed.open(":memory:");
+seedDb.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+for (let i = 0; i < 10000; i++) {
+	seedDb.exec(`INSERT INTO test (value) VALUES ('value ${i}')`);
+}
+const data = seedDb.serialize()!;
+
+await measure("compile + instantiate + load + first query", async () => {
+	const module = await WebAssembly.compile(wasmFile);
+	const sqlite = await SQLite.instantiate(module);
+	firstQuery(sqlite.load(data));
+});
+
+const cache = new Map<string, WebAssembly.Module>();
+const module = await SQLite.compile(wasmFile, cache);
+
+await measure("cached module + instantiate + load + first query", async () => {
+	const sqlite = await SQLite.instantiate(await SQLite.compile(wasmFile, cache));
+	firstQuery(sqlite.load(data));
+});
+
+const warmed = await SQLite.instantiate(module);
+const snapshot = warmed.snapshot(warmed.load(data));
+
+await measure("cached module + fromSnapshot + first query", async () => {
+	const sqlite = await SQLite.fromSnapshot(module, snapshot);
+	firstQuery(new Database(sqlite, snapshot.databases[0]));
+});
+
+// sqlite3.wasm has noop and vfsfileio built in, sqlite3-core.wasm has no extensions
+const coreWasmFile = await fs.readFile("sqlite/sqlite3-core.wasm");
+const coreModule = await SQLite.compile(coreWasmFile, cache);
+console.log(`default module size: ${wasmFile.byteLength} bytes`);
+console.log(`core module size: ${coreWasmFile.byteLength} bytes`);
+
+await measure("default: compile + instantiate", async () => {
+	await SQLite.instantiate(await WebAssembly.compile(wasmFile));
+});
+
+await measure("core: compile + instantiate", async () => {
+	await SQLite.instantiate(await WebAssembly.compile(coreWasmFile));
+});
+
+await measure("default: cached module + instantiate", async () => {
+	await SQLite.instantiate(module);
+});
+
+await measure("core: cached module + instantiate", async () => {
+	await SQLite.instantiate(coreModule);
+});
+
+for (const name of ["noop", "vfsfileio", "ngram"]) {
+	const extFile = await fs.readFile(`sqlite/exts/${name}.wasm`);
+	const ext = await WebAssembly.compile(extFile);
+	console.log(`${name} side module size: ${extFile.byteLength} bytes`);
+	await measure(`core: cached module + instantiate + loadExtension(${name})`, async () => {
+		const sqlite = await SQLite.instantiate(coreModule);
+		sqlite.open(":memory:").loadExtension(ext);
+	});
+}
@@ -20,6 +20,8 @@ export interface SQLiteExports extends WebAssembly.Exports {
 
 const exportsPostamble = `
 	memory: WebAssembly.Memory;
+	__indirect_function_table: WebAssembly.Table;
+	__stack_pointer: WebAssembly.Global;
 }
 `;
 
@@ -1,13 +1,16 @@
 #!/bin/sh
 
-loads=$(grep -hEo 'sqlite3[a-zA-Z]+Init' $@ | sed 's/^/\t\t|| /g' | sed 's/$/(db)/g')
-includes=$(echo $@ | tr ' ' '\n' | sed 's/^/#include "/g' | sed 's/$/"/g')
+loads=""
+if [ $# -gt 0 ]; then
+	echo $@ | tr ' ' '\n' | sed 's/^/#include "/g' | sed 's/$/"/g'
+	echo
+	loads=$(grep -hEo 'sqlite3[a-zA-Z]+Init' $@ | sed 's/^/\t\t|| /g' | sed 's/$/(db)/g')
+	loads="
+$loads"
+fi
 
 cat << EOF
-$includes
-
 int sqlite3_extra_autoext(sqlite3 *db) {
-	return SQLITE_OK
-$loads;
+	return SQLITE_OK$loads;
 }
 EOF
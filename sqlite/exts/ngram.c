@@ -0,0 +1,321 @@
+/*
+** 2026-10-18
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*/
+
+/*
+** FTS5 tokenizer "ngram". Every character of a run of CJK characters (Han,
+** Kana, Hangul) is indexed as a unigram, with the n-gram starting at it as a
+** colocated token. Everything else is split into words on punctuation and
+** white space, folding ASCII, Latin-1, Greek and Cyrillic letters to lower
+** case.
+**
+**   CREATE VIRTUAL TABLE t USING fts5(x, tokenize = 'ngram n 2');
+**
+** n defaults to 2 and may be 1 to 4. Queries use the n-gram at each
+** position where one fits and the unigram at the last n-1 positions of a
+** run, so that phrases line up with the document and highlight() and
+** snippet(), which only use the offsets of non-colocated tokens, mark
+** exactly the matched characters.
+*/
+
+#include <stddef.h>
+#include "sqlite3ext.h"
+
+#ifndef SQLITE_PRIVATE
+#define SQLITE_PRIVATE static
+#endif
+
+SQLITE_EXTENSION_INIT1
+
+#define NGRAM_DEFAULT_N 2
+#define NGRAM_MAX_N 4
+
+#define NGRAM_SEP 0
+#define NGRAM_WORD 1
+#define NGRAM_CJK 2
+
+typedef struct NgramTokenizer NgramTokenizer;
+struct NgramTokenizer {
+	int n;
+	char *aFold;
+	int nFold;
+};
+
+static int ngramDecode(const unsigned char *z, int n, unsigned int *pc) {
+	unsigned int c = z[0];
+	int len;
+	int i;
+
+	if (c < 0x80) {
+		*pc = c;
+		return 1;
+	} else if (c >= 0xf0) {
+		len = 4;
+		c &= 0x07;
+	} else if (c >= 0xe0) {
+		len = 3;
+		c &= 0x0f;
+	} else if (c >= 0xc0) {
+		len = 2;
+		c &= 0x1f;
+	} else {
+		*pc = 0xfffd;
+		return 1;
+	}
+
+	if (len > n) {
+		*pc = 0xfffd;
+		return n;
+	}
+	for (i = 1; i < len; i++) {
+		if ((z[i] & 0xc0) != 0x80) {
+			*pc = 0xfffd;
+			return i;
+		}
+		c = (c << 6) | (z[i] & 0x3f);
+	}
+	*pc = c;
+	return len;
+}
+
+static int ngramClass(unsigned int c) {
+	if (c < 0x80) {
+		if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+			return NGRAM_WORD;
+		}
+		return NGRAM_SEP;
+	}
+	if ((c >= 0x3040 && c <= 0x30ff)      /* Hiragana, Katakana */
+	 || (c >= 0x3400 && c <= 0x4dbf)      /* CJK Unified Ideographs Extension A */
+	 || (c >= 0x4e00 && c <= 0x9fff)      /* CJK Unified Ideographs */
+	 || (c >= 0xac00 && c <= 0xd7af)      /* Hangul Syllables */
+	 || (c >= 0xf900 && c <= 0xfaff)      /* CJK Compatibility Ideographs */
+	 || (c >= 0xff66 && c <= 0xff9f)      /* Halfwidth Katakana */
+	 || (c >= 0x20000 && c <= 0x3ffff)) { /* Supplementary and Tertiary Ideographic Planes */
+		return NGRAM_CJK;
+	}
+	if ((c >= 0x80 && c <= 0xbf)          /* Latin-1 controls and punctuation */
+	 || c == 0xd7 || c == 0xf7
+	 || (c >= 0x2000 && c <= 0x2bff)      /* General Punctuation to Miscellaneous Symbols and Arrows */
+	 || (c >= 0x3000 && c <= 0x303f)      /* CJK Symbols and Punctuation */
+	 || (c >= 0xfe30 && c <= 0xfe4f)      /* CJK Compatibility Forms */
+	 || (c >= 0xff00 && c <= 0xff0f)      /* Fullwidth punctuation */
+	 || (c >= 0xff1a && c <= 0xff20)
+	 || (c >= 0xff3b && c <= 0xff40)
+	 || (c >= 0xff5b && c <= 0xff65)
+	 || c == 0xfeff || c == 0xfffd) {
+		return NGRAM_SEP;
+	}
+	return NGRAM_WORD;
+}
+
+static unsigned int ngramLower(unsigned int c) {
+	if ((c >= 'A' && c <= 'Z')
+	 || (c >= 0xc0 && c <= 0xde && c != 0xd7)
+	 || (c >= 0x391 && c <= 0x3a9 && c != 0x3a2)
+	 || (c >= 0x410 && c <= 0x42f)) {
+		return c + 0x20;
+	}
+	if (c >= 0x400 && c <= 0x40f) {
+		return c + 0x50;
+	}
+	return c;
+}
+
+static int ngramFold(NgramTokenizer *p, int *pnFold, unsigned int c) {
+	unsigned char *z;
+
+	if (*pnFold + 4 > p->nFold) {
+		int nNew = p->nFold > 0 ? p->nFold * 2 : 64;
+		char *aNew = sqlite3_realloc(p->aFold, nNew);
+		if (aNew == NULL) {
+			return SQLITE_NOMEM;
+		}
+		p->aFold = aNew;
+		p->nFold = nNew;
+	}
+
+	c = ngramLower(c);
+	z = (unsigned char *)&p->aFold[*pnFold];
+	if (c < 0x80) {
+		z[0] = (unsigned char)c;
+		*pnFold += 1;
+	} else if (c < 0x800) {
+		z[0] = (unsigned char)(0xc0 | (c >> 6));
+		z[1] = (unsigned char)(0x80 | (c & 0x3f));
+		*pnFold += 2;
+	} else if (c < 0x10000) {
+		z[0] = (unsigned char)(0xe0 | (c >> 12));
+		z[1] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+		z[2] = (unsigned char)(0x80 | (c & 0x3f));
+		*pnFold += 3;
+	} else {
+		z[0] = (unsigned char)(0xf0 | (c >> 18));
+		z[1] = (unsigned char)(0x80 | ((c >> 12) & 0x3f));
+		z[2] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+		z[3] = (unsigned char)(0x80 | (c & 0x3f));
+		*pnFold += 4;
+	}
+	return SQLITE_OK;
+}
+
+static int ngramCreate(void *pCtx, const char **azArg, int nArg, Fts5Tokenizer **ppOut) {
+	NgramTokenizer *p;
+	int n = NGRAM_DEFAULT_N;
+	int i;
+
+	*ppOut = NULL;
+	for (i = 0; i < nArg; i += 2) {
+		const char *zVal = i + 1 < nArg ? azArg[i + 1] : NULL;
+		if (zVal == NULL || sqlite3_stricmp(azArg[i], "n") != 0
+		 || zVal[0] < '1' || zVal[0] > '0' + NGRAM_MAX_N || zVal[1] != '\0') {
+			return SQLITE_ERROR;
+		}
+		n = zVal[0] - '0';
+	}
+
+	p = sqlite3_malloc(sizeof(NgramTokenizer));
+	if (p == NULL) {
+		return SQLITE_NOMEM;
+	}
+	p->n = n;
+	p->aFold = NULL;
+	p->nFold = 0;
+	*ppOut = (Fts5Tokenizer *)p;
+	return SQLITE_OK;
+}
+
+static void ngramDelete(Fts5Tokenizer *pTok) {
+	NgramTokenizer *p = (NgramTokenizer *)pTok;
+	if (p != NULL) {
+		sqlite3_free(p->aFold);
+		sqlite3_free(p);
+	}
+}
+
+static int ngramTokenize(
+	Fts5Tokenizer *pTok,
+	void *pCtx,
+	int flags,
+	const char *pText, int nText,
+	int (*xToken)(void *, int, const char *, int, int, int)
+) {
+	NgramTokenizer *p = (NgramTokenizer *)pTok;
+	const unsigned char *z = (const unsigned char *)pText;
+	int bQuery = (flags & FTS5_TOKENIZE_QUERY) != 0;
+	int aStart[NGRAM_MAX_N]; /* offsets of the characters of the CJK run not yet indexed */
+	int nRun = 0;            /* number of entries in aStart */
+	int iWord = -1;          /* offset of the current word, or -1 */
+	int nFold = 0;           /* bytes of the current word in p->aFold */
+	int rc = SQLITE_OK;
+	int i = 0;
+	int j;
+
+	while (rc == SQLITE_OK) {
+		unsigned int c = 0;
+		int len = 0;
+		int cls = NGRAM_SEP;
+
+		if (i < nText) {
+			len = ngramDecode(&z[i], nText - i, &c);
+			cls = ngramClass(c);
+		}
+
+		if (cls != NGRAM_WORD && iWord >= 0) {
+			rc = xToken(pCtx, 0, p->aFold, nFold, iWord, i);
+			iWord = -1;
+			nFold = 0;
+		}
+		if (cls != NGRAM_CJK) {
+			/* no n-gram fits at the last characters of the run */
+			for (j = 0; j < nRun && rc == SQLITE_OK; j++) {
+				int iEnd = j + 1 < nRun ? aStart[j + 1] : i;
+				rc = xToken(pCtx, 0, &pText[aStart[j]], iEnd - aStart[j], aStart[j], iEnd);
+			}
+			nRun = 0;
+		}
+		if (rc != SQLITE_OK || i >= nText) {
+			break;
+		}
+
+		if (cls == NGRAM_WORD) {
+			if (iWord < 0) {
+				iWord = i;
+			}
+			rc = ngramFold(p, &nFold, c);
+		} else if (cls == NGRAM_CJK) {
+			aStart[nRun++] = i;
+			if (nRun == p->n) {
+				/* the n-gram starting at aStart[0] is complete */
+				if (p->n > 1 && !bQuery) {
+					rc = xToken(pCtx, 0, &pText[aStart[0]], aStart[1] - aStart[0], aStart[0], aStart[1]);
+				}
+				if (rc == SQLITE_OK) {
+					rc = xToken(pCtx, bQuery || p->n == 1 ? 0 : FTS5_TOKEN_COLOCATED,
+						&pText[aStart[0]], i + len - aStart[0], aStart[0], i + len);
+				}
+				for (j = 1; j < nRun; j++) {
+					aStart[j - 1] = aStart[j];
+				}
+				nRun--;
+			}
+		}
+		i += len;
+	}
+
+	if (rc == SQLITE_DONE) {
+		rc = SQLITE_OK;
+	}
+	return rc;
+}
+
+static fts5_tokenizer ngramTokenizer = {
+	ngramCreate,
+	ngramDelete,
+	ngramTokenize,
+};
+
+static int ngramInit(sqlite3 *db) {
+	int rc = SQLITE_OK;
+	fts5_api *pApi = NULL;
+	sqlite3_stmt *pStmt = NULL;
+
+	rc = sqlite3_prepare_v2(db, "SELECT fts5(?1)", -1, &pStmt, NULL);
+	if (rc != SQLITE_OK) {
+		return rc;
+	}
+	sqlite3_bind_pointer(pStmt, 1, (void *)&pApi, "fts5_api_ptr", NULL);
+	sqlite3_step(pStmt);
+	rc = sqlite3_finalize(pStmt);
+	if (rc != SQLITE_OK) {
+		return rc;
+	}
+	if (pApi == NULL) {
+		return SQLITE_ERROR;
+	}
+
+	return pApi->xCreateTokenizer(pApi, "ngram", NULL, &ngramTokenizer, NULL);
+}
+
+#ifndef SQLITE_CORE
+#ifdef _WIN32
+__declspec(dllexport)
+#endif
+int sqlite3_ngram_init(sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi) {
+	SQLITE_EXTENSION_INIT2(pApi);
+	(void)pzErrMsg; /* unused */
+	return ngramInit(db);
+}
+#else
+SQLITE_PRIVATE int sqlite3NgramInit(sqlite3 *db) {
+	return ngramInit(db);
+}
+#endif
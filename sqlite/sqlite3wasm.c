@@ -8,8 +8,12 @@
 __attribute__((import_module("imports"),import_name("sqlite3_wasm_log")))
 SQLITE_IMPORTED_API void sqlite3_wasm_log(const char *zLog);
 
+#ifndef SQLITE_WASM_EXTS
+#define SQLITE_WASM_EXTS "sqlite3exts.c"
+#endif
+
 #include "sqlite3.c"
-#include "sqlite3exts.c"
+#include SQLITE_WASM_EXTS
 #include "sqlite3wasm.h"
 
 #ifndef MAX_EXT_VFS
@@ -150,16 +154,23 @@ static int vfs_full_pathname(sqlite3_vfs *pVfs, const char *zName, int nOut, cha
 
 static void *vfs_dlopen(sqlite3_vfs *pVfs, const char *zFilename)
 {
-	return NULL;
+	return (void *)sqlite3_wasm_vfs_dlopen(pVfs, zFilename);
 }
 
 static void vfs_dlerror(sqlite3_vfs *pVfs, int nByte, char *zErrMsg)
 {
-	if (nByte > 0)
-	{
-		strncpy(zErrMsg, "Dynamic linking not supported", nByte - 1);
-		zErrMsg[nByte - 1] = '\0';
-	}
+	sqlite3_wasm_vfs_dlerror(pVfs, nByte, zErrMsg);
+}
+
+static void (*vfs_dlsym(sqlite3_vfs *pVfs, void *pHandle, const char *zSymbol))(void)
+{
+	/* function pointers are indices into the shared function table */
+	return (void (*)(void))sqlite3_wasm_vfs_dlsym(pVfs, (int)pHandle, zSymbol);
+}
+
+static void vfs_dlclose(sqlite3_vfs *pVfs, void *pHandle)
+{
+	sqlite3_wasm_vfs_dlclose(pVfs, (int)pHandle);
 }
 
 static int vfs_randomness(sqlite3_vfs *pVfs, int nByte, char *zOut)
@@ -182,6 +193,67 @@ static int vfs_get_last_error(sqlite3_vfs *pVfs, int nByte, char *zOut)
 	return sqlite3_wasm_vfs_get_last_error(pVfs, nByte, zOut);
 }
 
+static int fts5_tok_create(void *pCtx, const char **azArg, int nArg, Fts5Tokenizer **ppOut)
+{
+	int instanceId = 0;
+	int rc = sqlite3_wasm_fts5_tokenizer_create((int)pCtx, azArg, nArg, &instanceId);
+	*ppOut = rc == SQLITE_OK ? (Fts5Tokenizer *)instanceId : NULL;
+	return rc;
+}
+
+static void fts5_tok_delete(Fts5Tokenizer *pTok)
+{
+	sqlite3_wasm_fts5_tokenizer_delete((int)pTok);
+}
+
+/*
+** The JS tokenizer returns all tokens of a document in one buffer: nToken
+** records of {tflags, iStart, iEnd, nByte} followed by the token bytes.
+*/
+static int fts5_tok_tokenize(
+	Fts5Tokenizer *pTok,
+	void *pCtx,
+	int flags,
+	const char *pText, int nText,
+	int (*xToken)(void *, int, const char *, int, int, int)
+)
+{
+	int *aToken = NULL;
+	int nToken = 0;
+	int rc = sqlite3_wasm_fts5_tokenize((int)pTok, flags, pText, nText, &aToken, &nToken);
+	if (rc == SQLITE_OK && aToken != NULL) {
+		const char *zToken = (const char *)&aToken[nToken * 4];
+		for (int i = 0; i < nToken && rc == SQLITE_OK; i++) {
+			int *a = &aToken[i * 4];
+			rc = xToken(pCtx, a[0], zToken, a[3], a[1], a[2]);
+			zToken += a[3];
+		}
+	}
+	sqlite3_free(aToken);
+	if (rc == SQLITE_DONE) {
+		rc = SQLITE_OK;
+	}
+	return rc;
+}
+
+static fts5_tokenizer fts5_tok_methods = {
+	fts5_tok_create,
+	fts5_tok_delete,
+	fts5_tok_tokenize,
+};
+
+static fts5_api *fts5_api_get(sqlite3 *db)
+{
+	fts5_api *pApi = NULL;
+	sqlite3_stmt *pStmt = NULL;
+	if (sqlite3_prepare_v2(db, "SELECT fts5(?1)", -1, &pStmt, NULL) == SQLITE_OK) {
+		sqlite3_bind_pointer(pStmt, 1, (void *)&pApi, "fts5_api_ptr", NULL);
+		sqlite3_step(pStmt);
+	}
+	sqlite3_finalize(pStmt);
+	return pApi;
+}
+
 static int exec_callback(void *pArg, int nCols, char **azCols, char **azColNames)
 {
 	return sqlite3_wasm_exec_callback((int)pArg, nCols, azCols, azColNames);
@@ -221,8 +293,8 @@ int sqlite3_wasm_vfs_register(const char *name, int makeDflt, sqlite3_vfs **ppOu
 	pVfs->xFullPathname = vfs_full_pathname;
 	pVfs->xDlOpen = vfs_dlopen;
 	pVfs->xDlError = vfs_dlerror;
-	pVfs->xDlSym = NULL;
-	pVfs->xDlClose = NULL;
+	pVfs->xDlSym = vfs_dlsym;
+	pVfs->xDlClose = vfs_dlclose;
 	pVfs->xRandomness = vfs_randomness;
 	pVfs->xSleep = vfs_sleep;
 	pVfs->xCurrentTime = vfs_current_time;
@@ -298,6 +370,36 @@ int sqlite3_wasm_exec(sqlite3 *db, const char *sql, int id, char **errmsg)
 	return sqlite3_exec(db, sql, exec_callback, (void *)id, errmsg);
 }
 
+int sqlite3_wasm_load_extension(sqlite3 *db, const char *zFile, const char *zProc, char **pzErrMsg)
+{
+	int enabled = 0;
+	int rc = sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_LOAD_EXTENSION, -1, &enabled);
+	if (rc != SQLITE_OK) {
+		return rc;
+	}
+	if (!enabled) {
+		sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_LOAD_EXTENSION, 1, NULL);
+	}
+	rc = sqlite3_load_extension(db, zFile, zProc, pzErrMsg);
+	if (!enabled) {
+		sqlite3_db_config(db, SQLITE_DBCONFIG_ENABLE_LOAD_EXTENSION, 0, NULL);
+	}
+	return rc;
+}
+
+int sqlite3_wasm_fts5_create_tokenizer(sqlite3 *db, const char *zName, int iTokenizerId)
+{
+	fts5_api *pApi = fts5_api_get(db);
+	if (pApi == NULL) {
+		return SQLITE_ERROR;
+	}
+	return pApi->xCreateTokenizer(
+		pApi, zName, (void *)iTokenizerId,
+		&fts5_tok_methods,
+		sqlite3_wasm_fts5_tokenizer_destroy
+	);
+}
+
 SQLITE_EXTRA_API const sqlite3_api_routines *sqlite3_get_api_routines() {
 	return &sqlite3Apis;
 }
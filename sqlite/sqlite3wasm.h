@@ -12,6 +12,12 @@
 #define SQLITE_WASM_FUNC_MODE_AGGREGATE 1
 #define SQLITE_WASM_FUNC_MODE_WINDOW 2
 
+#define SQLITE_WASM_FTS5_TOKENIZE_QUERY 0x0001
+#define SQLITE_WASM_FTS5_TOKENIZE_PREFIX 0x0002
+#define SQLITE_WASM_FTS5_TOKENIZE_DOCUMENT 0x0004
+#define SQLITE_WASM_FTS5_TOKENIZE_AUX 0x0008
+#define SQLITE_WASM_FTS5_TOKEN_COLOCATED 0x0001
+
 __attribute__((import_module("imports"),import_name("sqlite3_wasm_log")))
 SQLITE_IMPORTED_API void sqlite3_wasm_log(const char *zLog);
 
@@ -102,6 +108,30 @@ SQLITE_IMPORTED_API void sqlite3_wasm_function_inverse(sqlite3_context *pCtx, in
 __attribute__((import_module("imports"),import_name("sqlite3_wasm_function_destroy")))
 SQLITE_IMPORTED_API void sqlite3_wasm_function_destroy(void *pArg);
 
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_vfs_dlopen")))
+SQLITE_IMPORTED_API int sqlite3_wasm_vfs_dlopen(sqlite3_vfs *pVfs, const char *zFilename);
+
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_vfs_dlerror")))
+SQLITE_IMPORTED_API void sqlite3_wasm_vfs_dlerror(sqlite3_vfs *pVfs, int nByte, char *zErrMsg);
+
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_vfs_dlsym")))
+SQLITE_IMPORTED_API int sqlite3_wasm_vfs_dlsym(sqlite3_vfs *pVfs, int handle, const char *zSymbol);
+
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_vfs_dlclose")))
+SQLITE_IMPORTED_API void sqlite3_wasm_vfs_dlclose(sqlite3_vfs *pVfs, int handle);
+
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_fts5_tokenizer_create")))
+SQLITE_IMPORTED_API int sqlite3_wasm_fts5_tokenizer_create(int iTokenizerId, const char **azArg, int nArg, int *pInstanceId);
+
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_fts5_tokenizer_delete")))
+SQLITE_IMPORTED_API void sqlite3_wasm_fts5_tokenizer_delete(int instanceId);
+
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_fts5_tokenize")))
+SQLITE_IMPORTED_API int sqlite3_wasm_fts5_tokenize(int instanceId, int flags, const char *pText, int nText, int **paToken, int *pnToken);
+
+__attribute__((import_module("imports"),import_name("sqlite3_wasm_fts5_tokenizer_destroy")))
+SQLITE_IMPORTED_API void sqlite3_wasm_fts5_tokenizer_destroy(void *pArg);
+
 SQLITE_EXTRA_API int sqlite3_wasm_vfs_register(const char *name, int makeDflt, sqlite3_vfs **ppOutVfs);
 
 SQLITE_EXTRA_API int sqlite3_wasm_vfs_unregister(sqlite3_vfs *pVfs);
@@ -110,4 +140,8 @@ SQLITE_EXTRA_API int sqlite3_wasm_create_function(sqlite3 *db, const char *zFunc
 
 SQLITE_EXTRA_API int sqlite3_wasm_exec(sqlite3 *db, const char *sql, int id, char **errmsg);
 
+SQLITE_EXTRA_API int sqlite3_wasm_load_extension(sqlite3 *db, const char *zFile, const char *zProc, char **pzErrMsg);
+
+SQLITE_EXTRA_API int sqlite3_wasm_fts5_create_tokenizer(sqlite3 *db, const char *zName, int iTokenizerId);
+
 SQLITE_EXTRA_API const sqlite3_api_routines *sqlite3_get_api_routines();
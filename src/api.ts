@@ -326,9 +326,13 @@ export interface SQLiteExports extends WebAssembly.Exports {
 	sqlite3_wasm_vfs_unregister: (pVfs: CPointer) => CInteger;
 	sqlite3_wasm_create_function: (db: CPointer, zFunctionName: CString, nArg: CInteger, eTextRep: CInteger, iFuncId: CInteger, mode: CInteger) => CInteger;
 	sqlite3_wasm_exec: (db: CPointer, sql: CString, id: CInteger, d: CPointer) => CInteger;
+	sqlite3_wasm_load_extension: (db: CPointer, zFile: CString, zProc: CString, d: CPointer) => CInteger;
+	sqlite3_wasm_fts5_create_tokenizer: (db: CPointer, zName: CString, iTokenizerId: CInteger) => CInteger;
 	sqlite3_get_api_routines: () => CPointer;
 
 	memory: WebAssembly.Memory;
+	__indirect_function_table: WebAssembly.Table;
+	__stack_pointer: WebAssembly.Global;
 }
 
 export interface SQLiteImports {
@@ -362,6 +366,14 @@ export interface SQLiteImports {
 	sqlite3_wasm_function_value: (pCtx: CPointer) => void;
 	sqlite3_wasm_function_inverse: (pCtx: CPointer, iArgc: CInteger, c: CPointer) => void;
 	sqlite3_wasm_function_destroy: (pArg: CPointer) => void;
+	sqlite3_wasm_vfs_dlopen: (pVfs: CPointer, zFilename: CString) => CInteger;
+	sqlite3_wasm_vfs_dlerror: (pVfs: CPointer, nByte: CInteger, zErrMsg: CPointer) => void;
+	sqlite3_wasm_vfs_dlsym: (pVfs: CPointer, handle: CInteger, zSymbol: CString) => CInteger;
+	sqlite3_wasm_vfs_dlclose: (pVfs: CPointer, handle: CInteger) => void;
+	sqlite3_wasm_fts5_tokenizer_create: (iTokenizerId: CInteger, b: CPointer, nArg: CInteger, pInstanceId: CPointer) => CInteger;
+	sqlite3_wasm_fts5_tokenizer_delete: (instanceId: CInteger) => void;
+	sqlite3_wasm_fts5_tokenize: (instanceId: CInteger, flags: CInteger, pText: CString, nText: CInteger, e: CPointer, pnToken: CPointer) => CInteger;
+	sqlite3_wasm_fts5_tokenizer_destroy: (pArg: CPointer) => void;
 }
 
 export class SQLiteUnimplementedImportError extends Error {
@@ -401,4 +413,12 @@ export const unimplementedImports: SQLiteImports = {
 	sqlite3_wasm_function_value: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_function_value") },
 	sqlite3_wasm_function_inverse: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_function_inverse") },
 	sqlite3_wasm_function_destroy: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_function_destroy") },
+	sqlite3_wasm_vfs_dlopen: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_vfs_dlopen") },
+	sqlite3_wasm_vfs_dlerror: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_vfs_dlerror") },
+	sqlite3_wasm_vfs_dlsym: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_vfs_dlsym") },
+	sqlite3_wasm_vfs_dlclose: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_vfs_dlclose") },
+	sqlite3_wasm_fts5_tokenizer_create: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_fts5_tokenizer_create") },
+	sqlite3_wasm_fts5_tokenizer_delete: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_fts5_tokenizer_delete") },
+	sqlite3_wasm_fts5_tokenize: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_fts5_tokenize") },
+	sqlite3_wasm_fts5_tokenizer_destroy: () => { throw new SQLiteUnimplementedImportError("sqlite3_wasm_fts5_tokenizer_destroy") },
 };
@@ -469,6 +469,11 @@ export const SESSION_CONFIG_STRMSIZE = 1;
 export const WASM_FUNC_MODE_SCALAR = 0;
 export const WASM_FUNC_MODE_AGGREGATE = 1;
 export const WASM_FUNC_MODE_WINDOW = 2;
+export const WASM_FTS5_TOKENIZE_QUERY = 1;
+export const WASM_FTS5_TOKENIZE_PREFIX = 2;
+export const WASM_FTS5_TOKENIZE_DOCUMENT = 4;
+export const WASM_FTS5_TOKENIZE_AUX = 8;
+export const WASM_FTS5_TOKEN_COLOCATED = 1;
 
 export const ResultCode = {
 	"OK": OK,
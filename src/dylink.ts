@@ -0,0 +1,271 @@
+import type { SQLiteExports } from "./api";
+import { ResultCode } from "./constants";
+import { SQLiteError } from "./types";
+import type { SQLiteUtils } from "./utils";
+
+const WASM_DYLINK_MEM_INFO = 1;
+
+interface DylinkInfo {
+	memorySize: number;
+	memoryAlign: number;
+	tableSize: number;
+	tableAlign: number;
+}
+
+function readDylinkInfo(module: WebAssembly.Module): DylinkInfo {
+	let sections = WebAssembly.Module.customSections(module, "dylink.0");
+	const legacy = sections.length === 0;
+	if (legacy) {
+		sections = WebAssembly.Module.customSections(module, "dylink");
+	}
+	if (sections.length === 0) {
+		throw new SQLiteError(ResultCode.ERROR, "not a side module (missing dylink section)");
+	}
+	const bytes = new Uint8Array(sections[0]);
+	let offset = 0;
+	const uleb = () => {
+		let result = 0;
+		let shift = 0;
+		let byte: number;
+		do {
+			byte = bytes[offset++];
+			result += (byte & 0x7f) * 2 ** shift;
+			shift += 7;
+		} while (byte & 0x80);
+		return result;
+	};
+	const memInfo = () => ({
+		memorySize: uleb(),
+		memoryAlign: uleb(),
+		tableSize: uleb(),
+		tableAlign: uleb(),
+	});
+	if (legacy) {
+		return memInfo();
+	}
+	while (offset < bytes.length) {
+		const type = uleb();
+		const size = uleb();
+		if (type === WASM_DYLINK_MEM_INFO) {
+			return memInfo();
+		}
+		offset += size;
+	}
+	return { memorySize: 0, memoryAlign: 0, tableSize: 0, tableAlign: 0 };
+}
+
+function alignUp(n: number, align: number): number {
+	return Math.ceil(n / align) * align;
+}
+
+/**
+ * Hands out ranges of function table slots, reusing the slots of closed
+ * side modules before growing the table.
+ */
+class TableAllocator {
+	/** Free ranges as [start, count], sorted by start and coalesced */
+	private readonly free: [number, number][] = [];
+
+	public constructor(public readonly table: WebAssembly.Table) {}
+
+	public alloc(count: number, align: number = 1): number {
+		for (let i = 0; i < this.free.length; i++) {
+			const [start, n] = this.free[i];
+			const base = alignUp(start, align);
+			if (base + count > start + n) {
+				continue;
+			}
+			const ranges: [number, number][] = [];
+			if (base > start) {
+				ranges.push([start, base - start]);
+			}
+			if (base + count < start + n) {
+				ranges.push([base + count, start + n - base - count]);
+			}
+			this.free.splice(i, 1, ...ranges);
+			return base;
+		}
+		const end = this.table.length;
+		const base = alignUp(end, align);
+		if (base + count > end) {
+			this.table.grow(base + count - end);
+		}
+		this.release(end, base - end);
+		return base;
+	}
+
+	public release(start: number, count: number): void {
+		if (count <= 0) {
+			return;
+		}
+		for (let i = start; i < start + count; i++) {
+			this.table.set(i, null);
+		}
+		let i = 0;
+		while (i < this.free.length && this.free[i][0] < start) {
+			i++;
+		}
+		this.free.splice(i, 0, [start, count]);
+		// merge with the following and the preceding range
+		if (i + 1 < this.free.length && start + count === this.free[i + 1][0]) {
+			this.free[i][1] += this.free[i + 1][1];
+			this.free.splice(i + 1, 1);
+		}
+		if (i > 0 && this.free[i - 1][0] + this.free[i - 1][1] === start) {
+			this.free[i - 1][1] += this.free[i][1];
+			this.free.splice(i, 1);
+		}
+	}
+}
+
+const allocators: WeakMap<WebAssembly.Table, TableAllocator> = new WeakMap();
+
+function tableAllocator(table: WebAssembly.Table): TableAllocator {
+	let allocator = allocators.get(table);
+	if (allocator === undefined) {
+		allocator = new TableAllocator(table);
+		allocators.set(table, allocator);
+	}
+	return allocator;
+}
+
+/**
+ * A side module instantiated against the memory, function table, stack
+ * pointer and exported symbols of the core module.
+ * Its data segment and function table slots are returned on close.
+ */
+export class DynamicLibrary {
+	private readonly symbols: Map<string, number> = new Map();
+	/** Function table slots taken by GOT.func entries and sym() */
+	private readonly slots: number[] = [];
+
+	private constructor(
+		private readonly allocator: TableAllocator,
+		private readonly instance: WebAssembly.Instance,
+		private readonly utils: SQLiteUtils,
+		private readonly pMemory: number,
+		private readonly tableBase: number,
+		private readonly tableSize: number,
+	) {}
+
+	public static load(exports: SQLiteExports, utils: SQLiteUtils, module: WebAssembly.Module): DynamicLibrary {
+		const info = readDylinkInfo(module);
+		const table = exports.__indirect_function_table;
+		if (!(table instanceof WebAssembly.Table) || !(exports.__stack_pointer instanceof WebAssembly.Global)) {
+			throw new SQLiteError(ResultCode.ERROR, "core module does not support side modules");
+		}
+
+		const memoryAlign = 2 ** info.memoryAlign;
+		const size = memoryAlign + info.memorySize;
+		const pMemory = utils.malloc(size);
+		if (pMemory === 0) {
+			throw new SQLiteError(ResultCode.NOMEM);
+		}
+		utils.u8.fill(0, pMemory, pMemory + size);
+		const memoryBase = alignUp(pMemory, memoryAlign);
+
+		const allocator = tableAllocator(table);
+		const tableBase = allocator.alloc(info.tableSize, 2 ** info.tableAlign);
+		let lib: DynamicLibrary | undefined;
+		try {
+			const env: WebAssembly.ModuleImports = {
+				memory: exports.memory,
+				__indirect_function_table: table,
+				__memory_base: new WebAssembly.Global({ value: "i32", mutable: false }, memoryBase),
+				__table_base: new WebAssembly.Global({ value: "i32", mutable: false }, tableBase),
+				// side modules run on the stack of the core, they are only ever called from it
+				__stack_pointer: exports.__stack_pointer,
+			};
+			const gotMem: Map<string, WebAssembly.Global> = new Map();
+			const gotFunc: Map<string, WebAssembly.Global> = new Map();
+			for (const imp of WebAssembly.Module.imports(module)) {
+				if (imp.module === "GOT.mem" || imp.module === "GOT.func") {
+					const got = new WebAssembly.Global({ value: "i32", mutable: true }, 0);
+					(imp.module === "GOT.mem" ? gotMem : gotFunc).set(imp.name, got);
+				} else if (imp.module === "env" && !(imp.name in env)) {
+					const sym = exports[imp.name];
+					if (imp.kind !== "function" || typeof sym !== "function") {
+						throw new SQLiteError(ResultCode.ERROR, `undefined symbol: ${imp.name}`);
+					}
+					env[imp.name] = sym;
+				}
+			}
+
+			const instance = new WebAssembly.Instance(module, {
+				env,
+				"GOT.mem": Object.fromEntries(gotMem),
+				"GOT.func": Object.fromEntries(gotFunc),
+			});
+			lib = new DynamicLibrary(allocator, instance, utils, pMemory, tableBase, info.tableSize);
+
+			for (const [name, got] of gotMem) {
+				const own = instance.exports[name];
+				const core = exports[name];
+				if (own instanceof WebAssembly.Global) {
+					got.value = memoryBase + own.value;
+				} else if (core instanceof WebAssembly.Global) {
+					got.value = core.value;
+				} else {
+					throw new SQLiteError(ResultCode.ERROR, `undefined symbol: ${name}`);
+				}
+			}
+			for (const [name, got] of gotFunc) {
+				const fn = instance.exports[name] ?? exports[name];
+				if (typeof fn !== "function") {
+					throw new SQLiteError(ResultCode.ERROR, `undefined symbol: ${name}`);
+				}
+				got.value = lib.addFunction(fn as Function);
+			}
+
+			const applyDataRelocs = instance.exports.__wasm_apply_data_relocs as (() => void) | undefined;
+			const callCtors = (instance.exports.__wasm_call_ctors ?? instance.exports._initialize) as (() => void) | undefined;
+			applyDataRelocs?.();
+			callCtors?.();
+			return lib;
+		} catch (e) {
+			if (lib !== undefined) {
+				lib.close();
+			} else {
+				allocator.release(tableBase, info.tableSize);
+				utils.free(pMemory);
+			}
+			throw e;
+		}
+	}
+
+	private addFunction(fn: Function): number {
+		const index = this.allocator.alloc(1);
+		this.allocator.table.set(index, fn);
+		this.slots.push(index);
+		return index;
+	}
+
+	/**
+	 * Looks up an exported function
+	 * @param name The symbol name
+	 * @returns The function table index of the symbol, or 0 if not found
+	 */
+	public sym(name: string): number {
+		const cached = this.symbols.get(name);
+		if (cached !== undefined) {
+			return cached;
+		}
+		const fn = this.instance.exports[name];
+		if (typeof fn !== "function") {
+			return 0;
+		}
+		const index = this.addFunction(fn);
+		this.symbols.set(name, index);
+		return index;
+	}
+
+	public close(): void {
+		for (const index of this.slots) {
+			this.allocator.release(index, 1);
+		}
+		this.slots.length = 0;
+		this.symbols.clear();
+		this.allocator.release(this.tableBase, this.tableSize);
+		this.utils.free(this.pMemory);
+	}
+}
@@ -1,3 +1,4 @@
 export * from "./sqlite";
 export { SQLiteError as Error } from "./types";
 export * as constants from "./constants";
+export type { Token, Tokenizer, TokenizerFactory } from "./tokenizer";
@@ -1,6 +1,6 @@
 import * as fs from "fs/promises";
 import { describe, expect, it, beforeAll } from "bun:test";
-import { SQLite } from "./sqlite.js";
+import { SQLite, Database } from "./sqlite.js";
 import { ResultCode } from "./constants.js";
 import { NodeVFS } from "./vfs/node.js";
 import * as constants from "./constants.js";
@@ -23,6 +23,22 @@ async function initDb() {
 	return sqlite.open(":memory:");
 }
 
+const coreModulePromise = fs.readFile("./sqlite/sqlite3-core.wasm").then((wasm) => WebAssembly.compile(wasm));
+
+async function initCoreSQLite() {
+	return await SQLite.instantiate(await coreModulePromise);
+}
+
+async function initCoreDb() {
+	const sqlite = await initCoreSQLite();
+	return sqlite.open(":memory:");
+}
+
+async function initExtension(name: string) {
+	const wasm = await fs.readFile(`./sqlite/exts/${name}.wasm`);
+	return await WebAssembly.compile(wasm);
+}
+
 describe("SQLite", function () {
 	describe("Basics", () => {
 		it("should support synchronous init", async function() {
@@ -457,6 +473,289 @@ describe("SQLite", function () {
 			expect(count).toBe(3);
 			db.close();
 		});
+
+		it("should support js tokenizers", async function() {
+			const db = await initDb();
+			const flags: number[] = [];
+			db.createTokenizer("words", {
+				tokenize(text, flag) {
+					flags.push(flag);
+					return Array.from(text.matchAll(/\S+/g), (m) => ({
+						token: m[0].toLowerCase(),
+						start: m.index!,
+						end: m.index! + m[0].length,
+					}));
+				},
+			});
+			db.exec("CREATE VIRTUAL TABLE test USING fts5(value, tokenize = 'words')");
+			db.exec("INSERT INTO test (value) VALUES ('Héllo Wörld')");
+			db.exec("INSERT INTO test (value) VALUES ('hello there')");
+			const values: (string | null)[] = [];
+			db.exec("SELECT highlight(test, 0, '[', ']') FROM test WHERE test MATCH 'wörld'", (_, cols) => {
+				values.push(cols[0]);
+			});
+			expect(values).toEqual(["Héllo [Wörld]"]);
+			expect(flags).toContain(constants.WASM_FTS5_TOKENIZE_DOCUMENT);
+			expect(flags).toContain(constants.WASM_FTS5_TOKENIZE_QUERY);
+			db.close();
+		});
+
+		it("should propagate js tokenizer errors", async function() {
+			const db = await initDb();
+			db.createTokenizer("broken", () => ({
+				tokenize() {
+					throw new Error("broken");
+				},
+			}));
+			db.exec("CREATE VIRTUAL TABLE test USING fts5(value, tokenize = 'broken')");
+			expect(() => db.exec("INSERT INTO test (value) VALUES ('hello')")).toThrow();
+			db.close();
+		});
+
+		it("should reject invalid token offsets", async function() {
+			const db = await initDb();
+			const utils = db.sqlite.utils;
+			for (const [start, end] of [[-1, 1], [2, 1], [0, 6], [0.5, 1]]) {
+				expect(() => utils.packTokens("hello", 5, [{ token: "hello", start, end }])).toThrow("invalid token offsets");
+			}
+			const ptr = utils.packTokens("héllo", 6, [{ token: "héllo", start: 0, end: 5 }]);
+			expect(Array.from(new Int32Array(utils.u8.buffer, ptr, 4))).toEqual([0, 0, 6, 6]);
+			utils.free(ptr);
+			db.close();
+		});
+
+		it("should support the ngram tokenizer", async function() {
+			const db = await initDb();
+			db.loadExtension(await initExtension("ngram"));
+			db.exec("CREATE VIRTUAL TABLE test USING fts5(value, tokenize = 'ngram')");
+			db.exec("INSERT INTO test (value) VALUES ('東京都の天気 Weather')");
+			db.exec("INSERT INTO test (value) VALUES ('京都 weather')");
+			const count = (query: string) => {
+				let n = 0;
+				db.exec(`SELECT * FROM test WHERE test MATCH '${query}'`, () => n++);
+				return n;
+			};
+			expect(count("東京")).toBe(1);
+			expect(count("京都")).toBe(2);
+			expect(count("京")).toBe(2);
+			expect(count("気")).toBe(1);
+			expect(count("天気")).toBe(1);
+			expect(count("weather")).toBe(2);
+			db.exec("SELECT highlight(test, 0, '[', ']') FROM test WHERE test MATCH '天気'", (_, cols) => {
+				expect(cols[0]).toBe("東京都の[天気] Weather");
+			});
+			const highlights: string[] = [];
+			db.exec("SELECT highlight(test, 0, '[', ']') FROM test WHERE test MATCH '京' ORDER BY rowid", (_, cols) => {
+				highlights.push(cols[0]!);
+			});
+			expect(highlights).toEqual(["東[京]都の天気 Weather", "[京]都 weather"]);
+			db.exec("SELECT snippet(test, 0, '[', ']', '…', 3) FROM test WHERE test MATCH '都' AND rowid = 1", (_, cols) => {
+				expect(cols[0]).toBe("東京[都]…");
+			});
+			db.exec("SELECT highlight(test, 0, '[', ']') FROM test WHERE test MATCH '東京都'", (_, cols) => {
+				expect(cols[0]).toBe("[東京都]の天気 Weather");
+			});
+			expect(() => db.exec("CREATE VIRTUAL TABLE bad USING fts5(value, tokenize = 'ngram n 9')")).toThrow();
+			db.close();
+		});
+	});
+
+	describe("Extensions", () => {
+		it("should load a side module", async function() {
+			const db = await initCoreDb();
+			expect(() => db.exec("SELECT noop('hello')")).toThrow();
+			db.loadExtension(await initExtension("noop"));
+			db.exec("SELECT noop('hello')", (_, cols) => {
+				expect(cols[0]).toBe("hello");
+			});
+			db.close();
+		});
+
+		it("should load a registered extension by name", async function() {
+			const sqlite = await initCoreSQLite();
+			sqlite.registerExtension("noop", await initExtension("noop"));
+			const db1 = sqlite.open(":memory:");
+			const db2 = sqlite.open(":memory:");
+			db1.loadExtension("noop");
+			db2.loadExtension("noop");
+			db1.close();
+			db2.exec("SELECT noop(42)", (_, cols) => {
+				expect(cols[0]).toBe("42");
+			});
+			db2.close();
+		});
+
+		it("should relocate side module data", async function() {
+			const db = await initCoreDb();
+			expect(() => db.exec("SELECT vfsreadfile()")).toThrow("no such function");
+			db.loadExtension(await initExtension("vfsfileio"));
+			expect(() => db.exec("SELECT vfsreadfile()")).toThrow("vfsreadfile() takes 1 or 2 argument(s)");
+			db.close();
+		});
+
+		it("should reuse function table slots", async function() {
+			const sqlite = await initCoreSQLite();
+			const module = await initExtension("noop");
+			const table = sqlite.exports.__indirect_function_table;
+			const db1 = sqlite.open(":memory:");
+			db1.loadExtension(module);
+			db1.loadExtension(module);
+			db1.close();
+			const length = table.length;
+			const db2 = sqlite.open(":memory:");
+			db2.loadExtension(module);
+			expect(table.length).toBe(length);
+			db2.close();
+			expect(() => sqlite.open(":memory:").loadExtension("wasm:1")).toThrow();
+		});
+
+		it("should include extensions in the default build", async function() {
+			const db = await initDb();
+			db.exec("SELECT noop('hello')", (_, cols) => {
+				expect(cols[0]).toBe("hello");
+			});
+			expect(() => db.exec("CREATE VIRTUAL TABLE test USING fts5(value, tokenize = 'ngram')")).toThrow();
+			db.close();
+		});
+
+		it("should fail on missing extension or entry point", async function() {
+			const db = await initCoreDb();
+			const module = await initExtension("noop");
+			expect(() => db.loadExtension("nosuchext")).toThrow();
+			expect(() => db.loadExtension(module, "sqlite3_nosuch_init")).toThrow();
+			db.close();
+		});
+	});
+
+	describe("Snapshot", () => {
+		it("should restore a warmed database from a snapshot", async function() {
+			const module = await modulePromise;
+			const sqlite = await SQLite.instantiate(module);
+			const db = sqlite.open(":memory:");
+			db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+			db.exec("INSERT INTO test (value) VALUES ('hello')");
+			db.createFunction("hello", (name) => `hello ${name}`);
+			const snapshot = sqlite.snapshot(db);
+			expect(snapshot.databases.length).toBe(1);
+
+			const restored = SQLite.fromSnapshot(module, snapshot, {
+				functions: { hello: (name) => `hi ${name}` },
+			}, false);
+			const restoredDb = new Database(restored, snapshot.databases[0]);
+			restoredDb.exec("INSERT INTO test (value) VALUES ('world')");
+			let count = 0;
+			restoredDb.exec("SELECT * FROM test", () => count++);
+			expect(count).toBe(2);
+			restoredDb.exec("SELECT hello('test')", (_, cols) => {
+				expect(cols[0]).toBe("hi test");
+			});
+
+			count = 0;
+			db.exec("SELECT * FROM test", () => count++);
+			expect(count).toBe(1);
+			restoredDb.close();
+			db.close();
+		});
+
+		it("should clone an instance", async function() {
+			const sqlite = await initSQLite();
+			const db = sqlite.open(":memory:");
+			db.createFunction("hello", (name) => `hello ${name}`);
+			const snapshot = sqlite.snapshot(db);
+			const cloned = await sqlite.clone(snapshot);
+			const clonedDb = new Database(cloned, snapshot.databases[0]);
+			clonedDb.exec("SELECT hello('test')", (_, cols) => {
+				expect(cols[0]).toBe("hello test");
+			});
+			clonedDb.close();
+			db.close();
+		});
+
+		it("should require functions when restoring", async function() {
+			const module = await modulePromise;
+			const sqlite = await SQLite.instantiate(module);
+			const db = sqlite.open(":memory:");
+			db.createFunction("hello", (name) => `hello ${name}`);
+			const snapshot = sqlite.snapshot(db);
+			expect(() => SQLite.fromSnapshot(module, snapshot, {}, false)).toThrow();
+			await expect(SQLite.fromSnapshot(module, snapshot, {})).rejects.toThrow();
+			db.close();
+		});
+
+		it("should reject ambiguous function names", async function() {
+			const module = await modulePromise;
+			const sqlite = await SQLite.instantiate(module);
+			const db1 = sqlite.open(":memory:");
+			const db2 = sqlite.open(":memory:");
+			db1.createFunction("hello", (name) => `hello ${name}`);
+			db2.createFunction("hello", (name) => `hi ${name}`);
+			db2.createFunction("add", { nArg: 2, func: (a, b) => Number(a) + Number(b) });
+			db2.createFunction("add", { nArg: 3, func: (a, b, c) => Number(a) + Number(b) + Number(c) });
+			const snapshot = sqlite.snapshot(db1, db2);
+			const add = {
+				"add/2": (a: any, b: any) => Number(a) + Number(b),
+				"add/3": (a: any, b: any, c: any) => Number(a) + Number(b) + Number(c),
+			};
+			expect(() => SQLite.fromSnapshot(module, snapshot, {
+				functions: { hello: (name) => `hello ${name}`, ...add },
+			}, false)).toThrow();
+
+			const [hello1, hello2] = snapshot.functions.filter((f) => f.name === "hello");
+			const restored = SQLite.fromSnapshot(module, snapshot, {
+				functions: add,
+				functionsById: {
+					[hello1.id]: (name) => `hello ${name}`,
+					[hello2.id]: (name) => `hi ${name}`,
+				},
+			}, false);
+			const restoredDb2 = new Database(restored, snapshot.databases[1]);
+			restoredDb2.exec("SELECT hello('test'), add(1, 2), add(1, 2, 3)", (_, cols) => {
+				expect(cols).toEqual(["hi test", "3.0", "6.0"]);
+			});
+			restoredDb2.close();
+			db1.close();
+			db2.close();
+		});
+
+		it("should reject snapshots of a different build", async function() {
+			const module = await modulePromise;
+			const sqlite = await SQLite.instantiate(module);
+			const snapshot = sqlite.snapshot();
+			expect(() => SQLite.fromSnapshot(module, { ...snapshot, fingerprint: "0" }, {}, false)).toThrow();
+			expect(SQLite.fromSnapshot(module, snapshot, {}, false)).toBeInstanceOf(SQLite);
+		});
+
+		it("should cache compiled modules by content", async function() {
+			const wasm = await fs.readFile("./sqlite/sqlite3.wasm");
+			const ext = await fs.readFile("./sqlite/exts/noop.wasm");
+			const cache = new Map<string, WebAssembly.Module>();
+			const module = await SQLite.compile(wasm, cache);
+			expect(await SQLite.compile(wasm, cache)).toBe(module);
+			expect(await SQLite.compile(ext, cache)).not.toBe(module);
+			expect(cache.size).toBe(2);
+		});
+
+		it("should support asynchronous module caches", async function() {
+			const wasm = await fs.readFile("./sqlite/sqlite3.wasm");
+			const store = new Map<string, WebAssembly.Module>();
+			const cache = {
+				get: async (key: string) => store.get(key),
+				set: async (key: string, module: WebAssembly.Module) => store.set(key, module),
+			};
+			const module = await SQLite.compile(wasm, cache);
+			expect(await SQLite.compile(new Uint8Array(wasm), cache)).toBe(module);
+			expect(store.size).toBe(1);
+		});
+
+		it("should reject databases with prepared statements", async function() {
+			const sqlite = await initSQLite();
+			const db = sqlite.open(":memory:");
+			const stmt = db.prepare("SELECT 1")!;
+			expect(() => sqlite.snapshot(db)).toThrow("prepared statements");
+			stmt.finalize();
+			expect(sqlite.snapshot(db).databases).toEqual([db.pDb]);
+			db.close();
+		});
 	});
 
 	describe("Utilities", () => {
@@ -3,15 +3,19 @@ import { ResultCode, Datatype, SyncFlag, LockLevel, AccessFlag, OpenFlag, VERSIO
 
 import * as constants from "./constants";
 import { SQLiteError, toScalar } from "./types";
-import { SQLiteUtils, mustGet } from "./utils";
+import { SQLiteUtils, mustGet, hash } from "./utils";
+import { DynamicLibrary } from "./dylink";
 import { VFS, VFSFile } from "./vfs/index";
 import { JSVFS } from "./vfs/js";
 
 import type { ExtendedScalar, Scalar } from "./types";
 import type { Function } from "./func";
+import type { Tokenizer, TokenizerFactory } from "./tokenizer";
 
 export class SQLite {
+	private readonly module: WebAssembly.Module;
 	private readonly instance: WebAssembly.Instance;
+	private readonly fingerprint: string;
 
 	private _vfsMap: Map<number, VFS> = new Map();
 	private _vfsLastErrorMap: Map<number, SQLiteError> = new Map();
@@ -19,6 +23,12 @@ export class SQLite {
 	private _fileMap: Map<number, VFSFile> = new Map();
 	private _fileId: number = 1;
 
+	private _extensionModules: Map<string, WebAssembly.Module> = new Map();
+	private _dlMap: Map<number, { name: string; module: WebAssembly.Module; lib: DynamicLibrary; refCount: number }> =
+		new Map();
+	private _dlId: number = 1;
+	private _dlError: string = "";
+
 	private _readCounter: number = 0;
 	private _writeCounter: number = 0;
 
@@ -28,16 +38,97 @@ export class SQLite {
 	/** @internal */
 	public _funcId: number = 1;
 
+	/** @internal */
+	public _funcSignatures: Map<number, FunctionSignature> = new Map();
+
+	/** @internal */
+	public _tokenizerMap: Map<number, TokenizerFactory> = new Map();
+
+	/** @internal */
+	public _tokenizerId: number = 1;
+
+	private _tokenizerInstanceMap: Map<number, Tokenizer> = new Map();
+
 	public readonly utils: SQLiteUtils;
 	public readonly exports: SQLiteExports;
 
 	/** @internal */
 	public _execCallback: SQLiteImports["sqlite3_wasm_exec_callback"] | undefined;
 
+	/**
+	 * Compiles the module, consulting the cache first
+	 * @param key The cache key, defaults to a digest of the source bytes.
+	 * The digest is computed once per source object, which must not be modified afterwards.
+	 */
+	public static async compile(source: BufferSource, cache?: ModuleCache, key?: string): Promise<WebAssembly.Module> {
+		if (cache === undefined) {
+			return await WebAssembly.compile(source);
+		}
+		key ??= await sourceDigest(source);
+		const cached = await cache.get(key);
+		if (cached !== undefined) {
+			return cached;
+		}
+		const module = await WebAssembly.compile(source);
+		await cache.set(key, module);
+		return module;
+	}
+
 	public static instantiate(module: WebAssembly.Module): Promise<SQLite>;
 	public static instantiate(module: WebAssembly.Module, async: true): Promise<SQLite>;
 	public static instantiate(module: WebAssembly.Module, async: false): SQLite;
 	public static instantiate(module: WebAssembly.Module, async: boolean = true): Promise<SQLite> | SQLite {
+		return SQLite.create(module, async, (sqlite) => sqlite.initialize());
+	}
+
+	public static fromSnapshot(module: WebAssembly.Module, snapshot: Snapshot, options?: SnapshotRestoreOptions): Promise<SQLite>;
+	public static fromSnapshot(module: WebAssembly.Module, snapshot: Snapshot, options: SnapshotRestoreOptions | undefined, async: true): Promise<SQLite>;
+	public static fromSnapshot(module: WebAssembly.Module, snapshot: Snapshot, options: SnapshotRestoreOptions | undefined, async: false): SQLite;
+	public static fromSnapshot(module: WebAssembly.Module, snapshot: Snapshot, options: SnapshotRestoreOptions = {}, async: boolean = true): Promise<SQLite> | SQLite {
+		const vfsMap: Map<number, VFS> = new Map();
+		const funcMap: Map<number, Function> = new Map();
+		const funcSignatures: Map<number, FunctionSignature> = new Map();
+		try {
+			for (const { id, name } of snapshot.vfs) {
+				const vfs = options.vfs?.find((v) => v.name === name) ?? (name === JSVFS.name ? new JSVFS() : undefined);
+				if (vfs === undefined) {
+					throw new SQLiteError(ResultCode.MISUSE, `VFS ${name} not provided for snapshot restore`);
+				}
+				vfsMap.set(id, vfs);
+			}
+
+			// a key is ambiguous if it would bind more than one registration
+			const keyCount: Map<string, number> = new Map();
+			for (const { name, nArg } of snapshot.functions) {
+				for (const key of [`${name}/${nArg}`, name]) {
+					keyCount.set(key, (keyCount.get(key) ?? 0) + 1);
+				}
+			}
+			for (const { id, name, nArg } of snapshot.functions) {
+				let func = options.functionsById?.[id];
+				if (func === undefined) {
+					const key = [`${name}/${nArg}`, name].find((k) => options.functions?.[k] !== undefined);
+					if (key === undefined) {
+						throw new SQLiteError(ResultCode.MISUSE, `Function ${name}/${nArg} not provided for snapshot restore`);
+					}
+					if (keyCount.get(key)! > 1) {
+						throw new SQLiteError(ResultCode.MISUSE, `Function ${key} is ambiguous in snapshot, restore it by id`);
+					}
+					func = options.functions![key];
+				}
+				funcMap.set(id, typeof func === "function" ? { func } : func);
+				funcSignatures.set(id, { name, nArg });
+			}
+		} catch (e) {
+			if (async) {
+				return Promise.reject(e);
+			}
+			throw e;
+		}
+		return SQLite.create(module, async, (sqlite) => sqlite.restore(snapshot, vfsMap, funcMap, funcSignatures));
+	}
+
+	private static create(module: WebAssembly.Module, async: boolean, setup: (sqlite: SQLite) => void): Promise<SQLite> | SQLite {
 		let sqlite: SQLite;
 
 		const imports: SQLiteImports = {
@@ -204,8 +295,82 @@ export class SQLite {
 			},
 			sqlite3_wasm_function_destroy(pArg) {
 				sqlite._funcMap.delete(pArg);
+				sqlite._funcSignatures.delete(pArg);
 				return;
 			},
+			sqlite3_wasm_vfs_dlopen(_, zFilename) {
+				const filename = sqlite.utils.decodeString(zFilename);
+				// sqlite retries with a shared library suffix appended
+				const name = sqlite._extensionModules.has(filename) ? filename : filename.replace(/\.so$/, "");
+				for (const [handle, dl] of sqlite._dlMap) {
+					if (dl.name === name) {
+						dl.refCount += 1;
+						return handle;
+					}
+				}
+				const module = sqlite._extensionModules.get(name);
+				if (module === undefined) {
+					sqlite._dlError = `${name}: extension not registered`;
+					return 0;
+				}
+				try {
+					const lib = DynamicLibrary.load(sqlite.exports, sqlite.utils, module);
+					const handle = sqlite._dlId++;
+					sqlite._dlMap.set(handle, { name, module, lib, refCount: 1 });
+					return handle;
+				} catch (e) {
+					sqlite._dlError = `${name}: ${e instanceof Error ? e.message : e}`;
+					return 0;
+				}
+			},
+			sqlite3_wasm_vfs_dlerror(_, nByte, zErrMsg) {
+				sqlite.utils.setString(zErrMsg, nByte, sqlite._dlError);
+			},
+			sqlite3_wasm_vfs_dlsym(_, handle, zSymbol) {
+				const dl = mustGet(sqlite._dlMap, handle);
+				const name = sqlite.utils.decodeString(zSymbol);
+				const index = dl.lib.sym(name);
+				if (index === 0) {
+					sqlite._dlError = `${dl.name}: undefined symbol: ${name}`;
+				}
+				return index;
+			},
+			sqlite3_wasm_vfs_dlclose(_, handle) {
+				const dl = mustGet(sqlite._dlMap, handle);
+				dl.refCount -= 1;
+				if (dl.refCount === 0) {
+					dl.lib.close();
+					sqlite._dlMap.delete(handle);
+				}
+			},
+			sqlite3_wasm_fts5_tokenizer_create(tokenizerId, azArg, nArg, pInstanceId) {
+				const factory = mustGet(sqlite._tokenizerMap, tokenizerId);
+				return sqlite.utils.wrapError(() => {
+					const args: string[] = [];
+					for (let i = 0; i < nArg; i++) {
+						args.push(sqlite.utils.decodeString(sqlite.utils.deref32(azArg + i * 4)));
+					}
+					const instanceId = sqlite._tokenizerId++;
+					sqlite._tokenizerInstanceMap.set(instanceId, factory(args));
+					sqlite.utils.dataView.setUint32(pInstanceId, instanceId, true);
+				}, true).code;
+			},
+			sqlite3_wasm_fts5_tokenizer_delete(instanceId) {
+				sqlite._tokenizerInstanceMap.delete(instanceId);
+			},
+			sqlite3_wasm_fts5_tokenize(instanceId, flags, pText, nText, paToken, pnToken) {
+				const tokenizer = mustGet(sqlite._tokenizerInstanceMap, instanceId);
+				return sqlite.utils.wrapError(() => {
+					const text = sqlite.utils.textDecoder.decode(sqlite.utils.u8.subarray(pText, pText + nText));
+					const tokens = tokenizer.tokenize(text, flags);
+					const ptr = sqlite.utils.packTokens(text, nText, tokens);
+					sqlite.utils.dataView.setUint32(paToken, ptr, true);
+					sqlite.utils.dataView.setUint32(pnToken, tokens.length, true);
+				}, true).code;
+			},
+			sqlite3_wasm_fts5_tokenizer_destroy(pArg) {
+				sqlite._tokenizerMap.delete(pArg);
+			},
 			sqlite3_wasm_os_init() {
 				const pId = sqlite.utils.malloc(4);
 				const pName = sqlite.utils.cString(JSVFS.name);
@@ -233,8 +398,8 @@ export class SQLite {
 					},
 				});
 
-				sqlite = new SQLite(instance);
-				sqlite.initialize();
+				sqlite = new SQLite(module, instance);
+				setup(sqlite);
 				return sqlite;
 			})();
 		} else {
@@ -243,16 +408,18 @@ export class SQLite {
 					...imports,
 				},
 			});
-			sqlite = new SQLite(instance);
-			sqlite.initialize();
+			sqlite = new SQLite(module, instance);
+			setup(sqlite);
 			return sqlite;
 		}
 	}
 
-	private constructor(instance: WebAssembly.Instance) {
+	private constructor(module: WebAssembly.Module, instance: WebAssembly.Instance) {
+		this.module = module;
 		this.instance = instance;
 		this.exports = this.instance.exports as SQLiteExports;
 		this.utils = new SQLiteUtils(this.exports);
+		this.fingerprint = moduleFingerprint(module, this.exports);
 	}
 
 	public initialize(): void {
@@ -264,6 +431,114 @@ export class SQLite {
 		this.utils.checkError(rc);
 	}
 
+	private restore(snapshot: Snapshot, vfsMap: Map<number, VFS>, funcMap: Map<number, Function>, funcSignatures: Map<number, FunctionSignature>): void {
+		if (snapshot.version !== VERSION_NUMBER) {
+			throw new Error(`SQLite version mismatch: expected ${VERSION_NUMBER}, got ${snapshot.version}`);
+		}
+		if (snapshot.fingerprint !== this.fingerprint) {
+			throw new SQLiteError(ResultCode.MISUSE, "Snapshot was taken from a different module build");
+		}
+		const memory = this.exports.memory;
+		const pages = Math.ceil(snapshot.memory.byteLength / WASM_PAGE_SIZE) - memory.buffer.byteLength / WASM_PAGE_SIZE;
+		if (pages > 0) {
+			memory.grow(pages);
+		}
+		this.utils.u8.set(new Uint8Array(snapshot.memory));
+		this._vfsMap = vfsMap;
+		this._funcMap = funcMap;
+		this._funcSignatures = funcSignatures;
+		this._funcId = snapshot.funcId;
+		this._fileId = snapshot.fileId;
+		const ver = this.exports.sqlite3_libversion_number();
+		if (ver !== VERSION_NUMBER) {
+			throw new Error(`SQLite version mismatch: expected ${VERSION_NUMBER}, got ${ver}`);
+		}
+	}
+
+	/**
+	 * Captures linear memory and the JS-side VFS and function tables so that
+	 * an initialized instance (and any open in-memory databases) can be
+	 * restored without re-running initialization.
+	 * Must not be called while a VFS file is open, an extension is loaded or
+	 * one of the databases has unfinalized statements.
+	 * @param databases Databases whose handles should be recorded in the snapshot
+	 * @returns The snapshot, which is structured-cloneable
+	 */
+	public snapshot(...databases: Database[]): Snapshot {
+		for (const db of databases) {
+			if (this.exports.sqlite3_next_stmt(db.pDb, 0) !== 0) {
+				throw new SQLiteError(ResultCode.MISUSE, "Cannot snapshot a database with prepared statements");
+			}
+		}
+		if (this._fileMap.size > 0) {
+			throw new SQLiteError(ResultCode.MISUSE, "Cannot snapshot while VFS files are open");
+		}
+		if (this._dlMap.size > 0) {
+			throw new SQLiteError(ResultCode.MISUSE, "Cannot snapshot while extensions are loaded");
+		}
+		if (this._tokenizerMap.size > 0) {
+			throw new SQLiteError(ResultCode.MISUSE, "Cannot snapshot while tokenizers are registered");
+		}
+		return {
+			version: VERSION_NUMBER,
+			fingerprint: this.fingerprint,
+			memory: this.utils.u8.slice().buffer as ArrayBuffer,
+			vfs: Array.from(this._vfsMap.keys()).map((id) => ({
+				id,
+				name: this.utils.decodeString(this.utils.deref32(id + VFS_ZNAME_OFFSET)),
+			})),
+			functions: Array.from(this._funcSignatures.entries()).map(([id, { name, nArg }]) => ({ id, name, nArg })),
+			funcId: this._funcId,
+			fileId: this._fileId,
+			databases: databases.map((db) => db.pDb),
+		};
+	}
+
+	public clone(snapshot?: Snapshot): Promise<SQLite>;
+	public clone(snapshot: Snapshot | undefined, async: true): Promise<SQLite>;
+	public clone(snapshot: Snapshot | undefined, async: false): SQLite;
+	public clone(snapshot: Snapshot = this.snapshot(), async: boolean = true): Promise<SQLite> | SQLite {
+		const vfsMap = new Map(this._vfsMap);
+		const funcMap = new Map(this._funcMap);
+		const funcSignatures = new Map(this._funcSignatures);
+		return SQLite.create(this.module, async, (sqlite) => sqlite.restore(snapshot, vfsMap, funcMap, funcSignatures));
+	}
+
+	/**
+	 * Registers a separately compiled extension (a wasm side module) so that it
+	 * can be loaded by name with {@link Database.loadExtension}
+	 * @param name The file name the extension is loaded as
+	 * @param module The compiled side module
+	 */
+	public registerExtension(name: string, module: WebAssembly.Module): void {
+		this._extensionModules.set(name, module);
+	}
+
+	/**
+	 * @internal
+	 * Runs load with the name a module is registered or already loaded as.
+	 * Unknown modules are registered under a temporary name for the duration of the call.
+	 */
+	public _withExtensionName<T>(module: WebAssembly.Module, load: (name: string) => T): T {
+		for (const [name, m] of this._extensionModules) {
+			if (m === module) {
+				return load(name);
+			}
+		}
+		for (const dl of this._dlMap.values()) {
+			if (dl.module === module) {
+				return load(dl.name);
+			}
+		}
+		const name = `wasm:${this._dlId}`;
+		this._extensionModules.set(name, module);
+		try {
+			return load(name);
+		} finally {
+			this._extensionModules.delete(name);
+		}
+	}
+
 	public registerVFS(vfs: VFS, makeDflt: boolean = false): void {
 		const pId = this.utils.malloc(4);
 		const pName = this.utils.cString(vfs.name);
@@ -340,6 +615,97 @@ export class SQLite {
 	}
 }
 
+const WASM_PAGE_SIZE = 65536;
+/** offsetof(sqlite3_vfs, zName) on wasm32 */
+const VFS_ZNAME_OFFSET = 16;
+
+const fingerprints: WeakMap<WebAssembly.Module, string> = new WeakMap();
+
+/**
+ * Identifies the build of a module by its imports, exports, initial table
+ * and memory size, and the addresses of its exported data symbols.
+ * Must be computed before the instance runs.
+ */
+const sourceDigests: WeakMap<object, Promise<string>> = new WeakMap();
+
+function sourceDigest(source: BufferSource): Promise<string> {
+	let digest = sourceDigests.get(source);
+	if (digest === undefined) {
+		const bytes = ArrayBuffer.isView(source)
+			? new Uint8Array(source.buffer, source.byteOffset, source.byteLength)
+			: new Uint8Array(source);
+		// crypto.subtle is missing in insecure browser contexts
+		digest = globalThis.crypto?.subtle === undefined
+			? Promise.resolve(`${bytes.byteLength}:${hash(bytes)}`)
+			: crypto.subtle.digest("SHA-256", bytes).then((buf) =>
+				Array.from(new Uint8Array(buf), (b) => b.toString(16).padStart(2, "0")).join(""));
+		sourceDigests.set(source, digest);
+	}
+	return digest;
+}
+
+function moduleFingerprint(module: WebAssembly.Module, exports: SQLiteExports): string {
+	let fingerprint = fingerprints.get(module);
+	if (fingerprint === undefined) {
+		const layout = [
+			JSON.stringify(WebAssembly.Module.imports(module)),
+			exports.__indirect_function_table?.length ?? 0,
+			exports.memory.buffer.byteLength,
+			...WebAssembly.Module.exports(module).map((e) => {
+				const value = exports[e.name];
+				return value instanceof WebAssembly.Global ? `${e.name}=${value.value}` : `${e.name}:${e.kind}`;
+			}),
+		].join("\n");
+		fingerprint = hash(new TextEncoder().encode(layout));
+		fingerprints.set(module, fingerprint);
+	}
+	return fingerprint;
+}
+
+interface FunctionSignature {
+	name: string;
+	nArg: number;
+}
+
+export interface Snapshot {
+	/** SQLite version number the snapshot was taken with */
+	version: number;
+	/** Identifies the module build the snapshot was taken from */
+	fingerprint: string;
+	/** Copy of the linear memory */
+	memory: ArrayBuffer;
+	/** Registered VFSes, rebound by registered name on restore */
+	vfs: { id: number; name: string }[];
+	/** Application defined functions, rebound by id, name and nArg, or name on restore */
+	functions: { id: number; name: string; nArg: number }[];
+	funcId: number;
+	fileId: number;
+	/** Database handles passed to {@link SQLite.snapshot}, see {@link Database} */
+	databases: CPointer[];
+}
+
+export interface SnapshotRestoreOptions {
+	/** VFS implementations for the VFSes recorded in the snapshot, matched by name */
+	vfs?: VFS[];
+	/**
+	 * Implementations for the functions recorded in the snapshot, keyed by
+	 * "name/nArg" or SQL function name. Keys matching more than one
+	 * registration are rejected.
+	 */
+	functions?: Record<string, ((...args: Scalar[]) => ExtendedScalar) | Function>;
+	/** Implementations keyed by the function ids recorded in the snapshot, takes precedence over functions */
+	functionsById?: Record<number, ((...args: Scalar[]) => ExtendedScalar) | Function>;
+}
+
+/**
+ * Stores compiled modules, e.g. a Map, or an asynchronous store shared with workers.
+ * Modules can only be shared where the host can clone them.
+ */
+export interface ModuleCache {
+	get(key: string): WebAssembly.Module | undefined | Promise<WebAssembly.Module | undefined>;
+	set(key: string, module: WebAssembly.Module): unknown;
+}
+
 export interface ExecValue {
 	name: string;
 	value: string | null;
@@ -377,12 +743,63 @@ export class Database {
 		const zName = this.utils.cString(name);
 		const funcId = this.sqlite._funcId++;
 		this.sqlite._funcMap.set(funcId, f);
+		this.sqlite._funcSignatures.set(funcId, { name, nArg: f.nArg ?? -1 });
 		const rc = this.sqlite.exports.sqlite3_wasm_create_function(this.pDb, zName, f.nArg ?? -1, flag, funcId, mode);
 		this.utils.free(zName);
 		this.utils.checkError(rc);
 		return;
 	}
 
+	/**
+	 * Registers an FTS5 tokenizer implemented in JS.
+	 * Each document is passed to the tokenizer in a single call and all of
+	 * its tokens are handed back to FTS5 in one packed buffer.
+	 * @param name The name used in the tokenize option of FTS5 tables
+	 * @param tokenizer The tokenizer, or a factory creating one per table
+	 */
+	public createTokenizer(name: string, tokenizer: Tokenizer | TokenizerFactory): void {
+		const factory = typeof tokenizer === "function" ? tokenizer : () => tokenizer;
+		const zName = this.utils.cString(name);
+		const tokenizerId = this.sqlite._tokenizerId++;
+		this.sqlite._tokenizerMap.set(tokenizerId, factory);
+		const rc = this.exports.sqlite3_wasm_fts5_create_tokenizer(this.pDb, zName, tokenizerId);
+		this.utils.free(zName);
+		if (rc !== ResultCode.OK) {
+			this.sqlite._tokenizerMap.delete(tokenizerId);
+		}
+		this.utils.checkError(rc);
+	}
+
+	/**
+	 * Loads a separately compiled extension into this database connection
+	 * @param module The compiled side module, or the name it was registered with
+	 * @param entryPoint The init function, defaults to the module's sqlite3_*_init export
+	 */
+	public loadExtension(module: WebAssembly.Module | string, entryPoint?: string): void {
+		if (typeof module !== "string") {
+			entryPoint ??= WebAssembly.Module.exports(module)
+				.find((e) => e.kind === "function" && /^sqlite3_\w+_init$/.test(e.name))?.name;
+			this.sqlite._withExtensionName(module, (name) => this.loadExtension(name, entryPoint));
+			return;
+		}
+		const zFile = this.utils.cString(module);
+		const zProc = entryPoint === undefined ? 0 : this.utils.cString(entryPoint);
+		const pzErrMsg = this.utils.malloc(4);
+		this.utils.dataView.setUint32(pzErrMsg, 0, true);
+		const rc = this.exports.sqlite3_wasm_load_extension(this.pDb, zFile, zProc, pzErrMsg);
+		const zErrMsg = this.utils.deref32(pzErrMsg);
+		const message = zErrMsg === 0 ? undefined : this.utils.decodeString(zErrMsg);
+		this.utils.free(zErrMsg);
+		this.utils.free(pzErrMsg);
+		if (zProc !== 0) {
+			this.utils.free(zProc);
+		}
+		this.utils.free(zFile);
+		if (rc !== ResultCode.OK) {
+			throw new SQLiteError(rc, message);
+		}
+	}
+
 	public prepare(sql: string): Statement | null {
 		const zSql = this.utils.cString(sql);
 		const ppStmt = this.exports.sqlite3_malloc(4);
@@ -0,0 +1,26 @@
+export interface Token {
+	/** The token text as it should be indexed or queried */
+	token: string;
+	/** Start offset of the token in the input text, in UTF-16 code units */
+	start: number;
+	/** End offset (exclusive) of the token in the input text, in UTF-16 code units */
+	end: number;
+	/** Whether the token is a synonym of the previous token */
+	colocated?: boolean;
+}
+
+export interface Tokenizer {
+	/**
+	 * Splits a whole document or query into tokens
+	 * @param text The text to tokenize
+	 * @param flags One of the WASM_FTS5_TOKENIZE_* constants
+	 * @returns All tokens of the text, in order
+	 */
+	tokenize(text: string, flags: number): Token[];
+}
+
+/**
+ * Creates a tokenizer instance for an FTS5 table
+ * @param args The arguments following the tokenizer name in the tokenize option
+ */
+export type TokenizerFactory = (args: string[]) => Tokenizer;
@@ -2,6 +2,7 @@ import type { SQLiteExports, CString } from "./api";
 import { ExtendedResultCode, ResultCode } from "./constants";
 import * as constants from "./constants";
 import type { Function } from "./func";
+import type { Token } from "./tokenizer";
 import { ExtendedScalar, Scalar, SQLiteError, toScalar } from "./types";
 
 export function mustGet<T, K>(map: Map<T, K>, key: T): K {
@@ -12,6 +13,20 @@ export function mustGet<T, K>(map: Map<T, K>, key: T): K {
 	return value;
 }
 
+/**
+ * Non-cryptographic 64-bit hash (two 32-bit FNV-1a variants) used for cache keys and fingerprints
+ */
+export function hash(bytes: Uint8Array): string {
+	let h1 = 0x811c9dc5;
+	let h2 = 0x050c5d1f;
+	for (let i = 0; i < bytes.length; i++) {
+		h1 = Math.imul(h1 ^ bytes[i], 0x01000193);
+		h2 = Math.imul(h2 ^ bytes[i], 0x5bd1e995);
+		h2 ^= h2 >>> 15;
+	}
+	return (h1 >>> 0).toString(16).padStart(8, "0") + (h2 >>> 0).toString(16).padStart(8, "0");
+}
+
 const sqliteOK = new SQLiteError(ResultCode.OK);
 
 export class SQLiteUtils {
@@ -76,10 +91,11 @@ export class SQLiteUtils {
 	}
 
 	public setString(ptr: number, nBytes: number, s: string): void {
-		const view = this.u8;
-		const buf = this.textEncoder.encode(s);
-		view.set(buf, ptr);
-		view[ptr + buf.length] = 0;
+		if (nBytes <= 0) {
+			return;
+		}
+		const { written } = this.textEncoder.encodeInto(s, this.u8.subarray(ptr, ptr + nBytes - 1));
+		this.u8[ptr + written] = 0;
 	}
 
 	public decodeString(ptr: number): string {
@@ -176,6 +192,63 @@ export class SQLiteUtils {
 		}
 	}
 
+	/**
+	 * Packs tokens into a buffer of {tflags, iStart, iEnd, nByte} records followed by the token bytes
+	 * @returns Pointer to the buffer, to be freed with sqlite3_free, or 0 if there are no tokens
+	 */
+	public packTokens(text: string, nText: number, tokens: Token[]): number {
+		if (tokens.length === 0) {
+			return 0;
+		}
+		let nUnits = 0;
+		for (const t of tokens) {
+			if (!Number.isInteger(t.start) || !Number.isInteger(t.end) || t.start < 0 || t.start > t.end || t.end > text.length) {
+				throw new SQLiteError(
+					ResultCode.ERROR,
+					`invalid token offsets ${t.start}..${t.end} for text of length ${text.length}`,
+				);
+			}
+			nUnits += t.token.length;
+		}
+		// a UTF-16 code unit never takes more than 3 bytes in UTF-8
+		const size = tokens.length * 16 + nUnits * 3;
+		const ptr = this.malloc(size);
+		if (ptr === 0) {
+			throw new SQLiteError(ResultCode.NOMEM);
+		}
+
+		// map UTF-16 offsets to UTF-8 byte offsets, unless the text is ASCII
+		let offsets: Uint32Array | undefined;
+		if (text.length !== nText) {
+			offsets = new Uint32Array(text.length + 1);
+			for (let i = 0; i < text.length; i++) {
+				const c = text.charCodeAt(i);
+				if (c >= 0xd800 && c < 0xdc00 && i + 1 < text.length) {
+					offsets[i + 1] = offsets[i] + 2;
+					offsets[i + 2] = offsets[i] + 4;
+					i++;
+				} else {
+					offsets[i + 1] = offsets[i] + (c < 0x80 ? 1 : c < 0x800 ? 2 : 3);
+				}
+			}
+		}
+		const byteOffset = (i: number) => Math.min(offsets === undefined ? i : offsets[i], nText);
+
+		const records = new Int32Array(this.exports.memory.buffer, ptr, tokens.length * 4);
+		const view = this.u8;
+		let pToken = ptr + tokens.length * 16;
+		for (let i = 0; i < tokens.length; i++) {
+			const t = tokens[i];
+			const { written } = this.textEncoder.encodeInto(t.token, view.subarray(pToken, ptr + size));
+			records[i * 4] = t.colocated ? constants.WASM_FTS5_TOKEN_COLOCATED : 0;
+			records[i * 4 + 1] = byteOffset(t.start);
+			records[i * 4 + 2] = byteOffset(t.end);
+			records[i * 4 + 3] = written;
+			pToken += written;
+		}
+		return ptr;
+	}
+
 	public lastError(dbPtr: number): SQLiteError | undefined {
 		const code = this.exports.sqlite3_errcode(dbPtr);
 		if (code === ResultCode.OK) {